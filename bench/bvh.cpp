@@ -0,0 +1,171 @@
+// compare BVH occlusion queries against the linear scan.
+// Usage: bench_bvh.exe [scene.obj]
+#include "../src/image.h" // min, max
+#include "../src/scene.h"
+#include "../src/raycast.h"
+#include "../src/wavefront.h"
+#include "common.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+// lightmap.cpp
+void computeNormals(Scene& s);
+
+namespace
+{
+void addBox(Scene& s, Vec3 lo, Vec3 hi)
+{
+  Vec3 p[8];
+
+  for(int i = 0; i < 8; ++i)
+    p[i] = { i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z };
+
+  addQuad(s, p[0], p[2], p[3], p[1]);
+  addQuad(s, p[4], p[5], p[7], p[6]);
+  addQuad(s, p[0], p[1], p[5], p[4]);
+  addQuad(s, p[2], p[6], p[7], p[3]);
+  addQuad(s, p[0], p[4], p[6], p[2]);
+  addQuad(s, p[1], p[3], p[7], p[5]);
+}
+
+// a ground plane covered with random boxes, like a city block
+Scene generateCity(int triangleCount)
+{
+  Scene s;
+  Random rnd;
+
+  addQuad(s, { -50, -50, 0 }, { 50, -50, 0 }, { 50, 50, 0 }, { -50, 50, 0 });
+
+  while(s.triangleCount() + 12 <= triangleCount)
+  {
+    auto base = rnd.next(Vec3 { -50, -50, 0 }, Vec3 { 50, 50, 0 });
+    auto size = rnd.next(Vec3 { 0.1f, 0.1f, 0.1f }, Vec3 { 2, 2, 5 });
+    addBox(s, base, base + size);
+  }
+
+  return s;
+}
+
+void run(const char* name, Scene& s)
+{
+  computeNormals(s);
+
+  Vec3 lo { 1e30f, 1e30f, 1e30f };
+  Vec3 hi = lo * -1;
+
+  for(auto& v : s.vertices)
+  {
+    lo = { min(lo.x, v.pos.x), min(lo.y, v.pos.y), min(lo.z, v.pos.z) };
+    hi = { max(hi.x, v.pos.x), max(hi.y, v.pos.y), max(hi.z, v.pos.z) };
+  }
+
+  // keep the linear scan under a few seconds
+  auto const rayCount = max(100, min(100000, int(2e8 / s.triangleCount())));
+
+  std::vector<Vec3> starts(rayCount);
+  std::vector<Vec3> deltas(rayCount);
+  Random rnd;
+
+  // shadow rays: from a light above the scene down to a receiver point
+  for(int i = 0; i < rayCount; ++i)
+  {
+    starts[i] = rnd.next(Vec3 { lo.x, lo.y, hi.z + 1 }, Vec3 { hi.x, hi.y, hi.z + 5 });
+    deltas[i] = rnd.next(lo, hi) - starts[i];
+  }
+
+  auto t0 = now();
+  s.bvh = buildBvh(s);
+  auto const buildTime = now() - t0;
+
+  std::vector<bool> expected(rayCount);
+
+  t0 = now();
+
+  for(int i = 0; i < rayCount; ++i)
+    expected[i] = raycastLinear(s, starts[i], deltas[i]);
+
+  auto const linearTime = now() - t0;
+
+  printf("%-12s %9d tris %7d rays | build %8.2f ms | linear %10.0f rays/s\n",
+         name, s.triangleCount(), rayCount, buildTime * 1000.0, rayCount / linearTime);
+
+  for(auto kernel : { "scalar", "sse", "avx2" })
+  {
+    if(!selectRaycastKernel(kernel))
+      continue;
+
+    int mismatches = 0;
+    t0 = now();
+
+    for(int i = 0; i < rayCount; ++i)
+      mismatches += raycast(s, starts[i], deltas[i]) != expected[i];
+
+    auto const bvhTime = now() - t0;
+
+    printf("    bvh+%-6s %10.0f rays/s | x%.1f | %d mismatches\n",
+           kernel, rayCount / bvhTime, linearTime / bvhTime, mismatches);
+  }
+
+  // packets: 8x8 receiver points on a small patch, towards the same light
+  auto const packetCount = max(1, rayCount / 64);
+  std::vector<Vec3> packetStarts(packetCount);
+  std::vector<Vec3> packetDeltas(packetCount * 64);
+
+  for(int p = 0; p < packetCount; ++p)
+  {
+    packetStarts[p] = rnd.next(Vec3 { lo.x, lo.y, hi.z + 1 }, Vec3 { hi.x, hi.y, hi.z + 5 });
+    auto const center = rnd.next(lo, hi);
+
+    for(int i = 0; i < 64; ++i)
+    {
+      auto const target = center + Vec3 { (i % 8) * 0.01f, (i / 8) * 0.01f, 0 };
+      packetDeltas[p * 64 + i] = target - packetStarts[p];
+    }
+  }
+
+  std::vector<bool> expectedPacket(packetCount * 64);
+  t0 = now();
+
+  for(int p = 0; p < packetCount; ++p)
+    for(int i = 0; i < 64; ++i)
+      expectedPacket[p * 64 + i] = raycast(s, packetStarts[p], packetDeltas[p * 64 + i]);
+
+  auto const singleTime = now() - t0;
+
+  int mismatches = 0;
+  t0 = now();
+
+  for(int p = 0; p < packetCount; ++p)
+  {
+    bool visible[64];
+    raycastPacket(s, packetStarts[p], &packetDeltas[p * 64], 64, visible);
+
+    for(int i = 0; i < 64; ++i)
+      mismatches += visible[i] != expectedPacket[p * 64 + i];
+  }
+
+  auto const packetTime = now() - t0;
+
+  printf("    single      %10.0f rays/s | packet %10.0f rays/s | x%.1f | %d mismatches\n",
+         packetCount * 64 / singleTime, packetCount * 64 / packetTime, singleTime / packetTime, mismatches);
+}
+}
+
+int main(int argc, char* argv[])
+{
+  auto const path = argc > 1 ? argv[1] : "data/input/scene.obj";
+
+  auto s = loadSceneAsObj(path);
+  run("scene.obj", s);
+
+  for(int count : { 10000, 100000, 1000000 })
+  {
+    char name[32];
+    snprintf(name, sizeof name, "city-%d", count);
+    auto city = generateCity(count);
+    run(name, city);
+  }
+
+  return 0;
+}
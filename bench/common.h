@@ -0,0 +1,42 @@
+// helpers shared by the benchmarks and the tests.
+#pragma once
+
+#include "../src/scene.h"
+
+#include <chrono>
+#include <cstdint>
+
+inline double now()
+{
+  using namespace std::chrono;
+  return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+// deterministic, so runs can be compared
+struct Random
+{
+  uint32_t state = 12345;
+
+  float next(float lo, float hi)
+  {
+    state = state * 1664525u + 1013904223u;
+    return lo + (hi - lo) * ((state >> 8) / 16777216.0f);
+  }
+
+  Vec3 next(Vec3 lo, Vec3 hi)
+  {
+    return { next(lo.x, hi.x), next(lo.y, hi.y), next(lo.z, hi.z) };
+  }
+};
+
+// two triangles, 'a b c' and 'a c d', on four new vertices
+inline void addQuad(Scene& s, Vec3 a, Vec3 b, Vec3 c, Vec3 d)
+{
+  auto const first = (uint32_t)s.vertices.size();
+
+  for(auto p : { a, b, c, d })
+    s.vertices.push_back({ p, {}, {} });
+
+  for(auto i : { 0, 1, 2, 0, 2, 3 })
+    s.indices.push_back(first + i);
+}
@@ -0,0 +1,95 @@
+// rasterizer fill rate, with a trivial shader.
+// Usage: bench_raster.exe
+#include "../src/rasterizer.h"
+#include "common.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+struct UvTriangle
+{
+  Vec2 v[3];
+};
+
+// right triangles of 'size' texels, in the winding accepted by the rasterizer
+std::vector<UvTriangle> generateGrid(int size, int imageSize)
+{
+  std::vector<UvTriangle> r;
+  auto const step = (float)size / imageSize;
+
+  for(float y = 0; y + step <= 1; y += step)
+  {
+    for(float x = 0; x + step <= 1; x += step)
+      r.push_back({ { { x, y }, { x, y + step }, { x + step, y } } });
+  }
+
+  return r;
+}
+
+// long triangles of 'width' texels along the diagonal of the image
+std::vector<UvTriangle> generateThin(int width, int imageSize, int count)
+{
+  std::vector<UvTriangle> r;
+  Random rnd;
+  auto const w = (float)width / imageSize;
+
+  for(int i = 0; i < count; ++i)
+  {
+    auto const x = rnd.next(0, 0.5f);
+    r.push_back({ { { x, 0 }, { x + 0.5f, 1 }, { x + w, 0 } } });
+  }
+
+  return r;
+}
+
+void run(const char* name, std::vector<UvTriangle> const& tris, int imageSize)
+{
+  std::vector<Pixel> pixels(imageSize * imageSize);
+  auto const clip = Rect { 0, 0, imageSize, imageSize };
+  auto const attr = Attributes { { 0, 0, 0 }, { 0, 0, 1 } };
+
+  int64_t texels = 0;
+
+  auto shader = [&] (Fragment const* frags, int count)
+    {
+      for(int i = 0; i < count; ++i)
+        pixels[frags[i].x + frags[i].y * imageSize] = { frags[i].pos.x, frags[i].N.z, 0, 1 };
+
+      texels += count;
+    };
+
+  int repeats = 0;
+  auto const t0 = now();
+
+  do
+  {
+    for(auto& t : tris)
+      rasterizeTriangle(imageSize, imageSize, clip, t.v[0], attr, t.v[1], attr, t.v[2], attr, shader);
+
+    ++repeats;
+  }
+  while(now() - t0 < 0.5);
+
+  auto const elapsed = now() - t0;
+
+  printf("%-16s %8d tris | %8.1f Mtexels/s | %10.1f Ktris/s\n",
+         name, (int)tris.size(), texels / elapsed * 1e-6, tris.size() * repeats / elapsed * 1e-3);
+}
+}
+
+int main()
+{
+  auto const imageSize = 2048;
+
+  run("grid-4px", generateGrid(4, imageSize), imageSize);
+  run("grid-16px", generateGrid(16, imageSize), imageSize);
+  run("grid-128px", generateGrid(128, imageSize), imageSize);
+  run("grid-1024px", generateGrid(1024, imageSize), imageSize);
+  run("thin-2px", generateThin(2, imageSize, 1000), imageSize);
+  run("thin-16px", generateThin(16, imageSize, 200), imageSize);
+
+  return 0;
+}
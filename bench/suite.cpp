@@ -0,0 +1,466 @@
+// per-stage timings of the whole bake, on generated scenes.
+// Usage: bench_suite.exe [--triangles N,N,...] [--lights N] [--occlusion F] [--size N] [--repeat N] [--threads N]
+//                        [--update-reference]
+//
+// Each scene is a tessellated ground plane with boxes standing on it.
+// 'occlusion' is the fraction of the ground covered by the boxes.
+// The stages run 'repeat' times. The report gives the median and the
+// 10th and 90th percentiles of each one, plus checksums of the baked
+// lightmap and of the written files: these must not change when only
+// the speed should. They are compared against those stored in
+// 'bench/reference.txt' for the same scene, and the suite fails if any
+// differs. '--update-reference' stores them instead, after a change
+// meant to alter the output.
+#include "../src/scene.h"
+#include "../src/image.h"
+#include "../src/wavefront.h"
+#include "../src/packer.h"
+#include "../src/parallel.h"
+#include "../src/targa.h"
+#include "../src/lightcache.h"
+#include "../src/hash.h"
+#include "common.h"
+
+#include <algorithm> // sort
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// lightmap.cpp
+void computeNormals(Scene& s);
+template<typename Format> uint64_t bakeLightmap(Scene& s, ImageOf<Format> img, int shadowStep, LightCapture* capture);
+template<typename Format> void dilate(ImageOf<Format> img, int radius);
+template<typename Format> void blur(ImageOf<Format> img, int radius, int passes);
+
+namespace
+{
+auto const SCENE_PATH = "out/bench_scene.obj";
+auto const MESH_PATH = "out/bench_mesh.obj";
+auto const LIGHTMAP_PATH = "out/bench_lightmap.tga";
+auto const REFERENCE_PATH = "bench/reference.txt";
+
+// same post-processing as lb.exe's defaults
+auto const DILATE_RADIUS = 8;
+auto const BLUR_RADIUS = 2;
+
+uint64_t checksumFile(const char* path)
+{
+  Hash r;
+  FILE* fp = fopen(path, "rb");
+
+  if(!fp)
+    return 0;
+
+  std::vector<uint8_t> buffer(1 << 20);
+  size_t n;
+
+  while((n = fread(buffer.data(), 1, buffer.size(), fp)) > 0)
+    r.add(buffer.data(), n);
+
+  fclose(fp);
+  return r.value;
+}
+
+// Writes the scene as OBJ: a ground plane of 100 x 100 units tessellated in
+// quads, and boxes covering 'occlusion' of it. Half the triangles go to the
+// boxes, unless there's no occlusion.
+void generateScene(const char* path, int triangleCount, float occlusion)
+{
+  FILE* fp = fopen(path, "wb");
+
+  if(!fp)
+  {
+    fprintf(stderr, "Can't write '%s'\n", path);
+    exit(1);
+  }
+
+  Random rnd;
+  int vertexCount = 0;
+
+  auto vertex = [&] (float x, float y, float z)
+    {
+      fprintf(fp, "v %g %g %g\n", x, y, z);
+      return ++vertexCount;
+    };
+
+  // flat shaded, with these normals
+  enum { UP = 1, FRONT, BACK, LEFT, RIGHT, DOWN };
+  fprintf(fp, "vn 0 0 1\nvn 0 -1 0\nvn 0 1 0\nvn -1 0 0\nvn 1 0 0\nvn 0 0 -1\n");
+
+  auto quad = [&] (int n, int a, int b, int c, int d)
+    {
+      fprintf(fp, "f %d//%d %d//%d %d//%d\nf %d//%d %d//%d %d//%d\n", a, n, b, n, c, n, a, n, c, n, d, n);
+    };
+
+  auto const boxCount = occlusion > 0 ? triangleCount / 24 : 0;
+  auto const groundTriangles = max(2, triangleCount - boxCount * 12);
+  auto const cells = max(1, (int)sqrt(groundTriangles / 2.0));
+  auto const extent = 100.0f;
+
+  // ground
+  auto const first = vertexCount + 1;
+
+  for(int y = 0; y <= cells; ++y)
+    for(int x = 0; x <= cells; ++x)
+      vertex(x * extent / cells - extent / 2, y * extent / cells - extent / 2, 0);
+
+  for(int y = 0; y < cells; ++y)
+  {
+    for(int x = 0; x < cells; ++x)
+    {
+      auto const i = first + x + y * (cells + 1);
+      quad(UP, i, i + 1, i + cells + 2, i + cells + 1);
+    }
+  }
+
+  // boxes
+  auto const footprint = boxCount ? sqrt(occlusion * extent * extent / boxCount) : 0.0f;
+
+  for(int b = 0; b < boxCount; ++b)
+  {
+    auto const sx = footprint * rnd.next(0.5f, 1.5f);
+    auto const sy = footprint * footprint / sx;
+    auto const sz = footprint * rnd.next(0.5f, 3.0f);
+    auto const x0 = rnd.next(-extent / 2, extent / 2 - sx);
+    auto const y0 = rnd.next(-extent / 2, extent / 2 - sy);
+
+    int p[8];
+
+    for(int i = 0; i < 8; ++i)
+      p[i] = vertex(i & 1 ? x0 + sx : x0, i & 2 ? y0 + sy : y0, i & 4 ? sz : 0);
+
+    quad(UP, p[4], p[5], p[7], p[6]);
+    quad(FRONT, p[0], p[1], p[5], p[4]);
+    quad(BACK, p[2], p[6], p[7], p[3]);
+    quad(LEFT, p[0], p[4], p[6], p[2]);
+    quad(RIGHT, p[1], p[3], p[7], p[5]);
+    quad(DOWN, p[0], p[2], p[3], p[1]);
+  }
+
+  fclose(fp);
+}
+
+// point lights above the ground, bright enough to reach a few boxes away
+void addLights(Scene& s, int count)
+{
+  Random rnd;
+  rnd.state = 777;
+
+  for(int i = 0; i < count; ++i)
+  {
+    Light light;
+    light.pos = { rnd.next(-50, 50), rnd.next(-50, 50), rnd.next(1, 10) };
+    light.color = { rnd.next(1, 4), rnd.next(1, 4), rnd.next(1, 4) };
+    light.falloff = 0.5f / 256;
+    s.lights.push_back(light);
+  }
+}
+
+struct Config
+{
+  std::vector<int> triangleCounts { 1000, 10000, 100000, 1000000 };
+  int lights = 16;
+  float occlusion = 0.3f;
+  int size = 1024;
+  int repeat = 5;
+  int threads = (int)std::thread::hardware_concurrency();
+  bool updateReference = false;
+};
+
+// The checksums of one scene. Stored one per line, as
+// 'triangles lights occlusion size bake mesh tga', the checksums in hex.
+struct Reference
+{
+  int triangles, lights;
+  float occlusion;
+  int size;
+  uint64_t bake, mesh, targa;
+
+  bool sameScene(Reference const& other) const
+  {
+    return triangles == other.triangles && lights == other.lights && occlusion == other.occlusion && size == other.size;
+  }
+};
+
+std::vector<Reference> loadReferences(const char* path)
+{
+  std::vector<Reference> r;
+  FILE* fp = fopen(path, "rb");
+
+  if(!fp)
+    return r;
+
+  Reference ref;
+  unsigned long long bake, mesh, targa;
+
+  while(fscanf(fp, "%d %d %f %d %llx %llx %llx", &ref.triangles, &ref.lights, &ref.occlusion, &ref.size, &bake, &mesh, &targa) == 7)
+  {
+    ref.bake = bake;
+    ref.mesh = mesh;
+    ref.targa = targa;
+    r.push_back(ref);
+  }
+
+  fclose(fp);
+  return r;
+}
+
+bool saveReferences(const char* path, std::vector<Reference> const& refs)
+{
+  FILE* fp = fopen(path, "wb");
+
+  if(!fp)
+    return false;
+
+  for(auto& ref : refs)
+  {
+    fprintf(fp, "%d %d %.9g %d %016llx %016llx %016llx\n", ref.triangles, ref.lights, ref.occlusion, ref.size,
+            (unsigned long long)ref.bake, (unsigned long long)ref.mesh, (unsigned long long)ref.targa);
+  }
+
+  return fclose(fp) == 0;
+}
+
+const char* const STAGES[] =
+{
+  "loadSceneAsObj",
+  "buildBvh",
+  "packTriangles",
+  "dumpSceneAsObj",
+  "bakeLightmap",
+  "dilate",
+  "blur",
+  "writeTarga",
+};
+
+auto const STAGE_COUNT = int(sizeof(STAGES) / sizeof(*STAGES));
+
+struct Run
+{
+  double seconds[STAGE_COUNT];
+  uint64_t bakeChecksum, meshChecksum, targaChecksum;
+};
+
+Run runOnce(Config const& cfg)
+{
+  Run r;
+  int stage = 0;
+  double t0 = now();
+
+  auto endStage = [&] ()
+    {
+      auto const t1 = now();
+      r.seconds[stage++] = t1 - t0;
+      t0 = t1;
+    };
+
+  auto s = loadSceneAsObj(SCENE_PATH);
+  endStage();
+
+  computeNormals(s);
+  s.bvh = buildBvh(s);
+  addLights(s, cfg.lights);
+  endStage();
+
+  packTriangles(s, PackMode::Grid, cfg.size, cfg.size);
+  endStage();
+
+  dumpSceneAsObj(s, MESH_PATH);
+  endStage();
+
+  Image img;
+  img.stride = img.width = img.height = cfg.size;
+  std::vector<Pixel> pixels((size_t)img.width * img.height);
+  img.pels = pixels.data();
+
+  bakeLightmap(s, img, 1, nullptr);
+  endStage();
+
+  Hash bake;
+  bake.add(pixels.data(), pixels.size() * sizeof(Pixel));
+
+  // the clock was stopped by the checksum
+  t0 = now();
+
+  dilate(img, DILATE_RADIUS);
+  endStage();
+
+  blur(img, BLUR_RADIUS, 1);
+  endStage();
+
+  writeTarga(img, LIGHTMAP_PATH);
+  endStage();
+
+  r.bakeChecksum = bake.value;
+  r.meshChecksum = checksumFile(MESH_PATH);
+  r.targaChecksum = checksumFile(LIGHTMAP_PATH);
+  return r;
+}
+
+// nearest rank
+double percentile(std::vector<double> values, double p)
+{
+  std::sort(values.begin(), values.end());
+  auto const rank = (int)ceil(p / 100.0 * values.size());
+  return values[clamp(rank - 1, 0, (int)values.size() - 1)];
+}
+
+// false if the checksums changed between runs, or differ from the reference
+bool benchScene(Config const& cfg, int triangleCount, std::vector<Reference>& refs)
+{
+  generateScene(SCENE_PATH, triangleCount, cfg.occlusion);
+
+  printf("scene: %d triangles, %d lights, occlusion %.2f, lightmap %d^2, %d runs, %d threads\n",
+         triangleCount, cfg.lights, cfg.occlusion, cfg.size, cfg.repeat, threadCount());
+
+  std::vector<Run> runs;
+
+  for(int i = 0; i < cfg.repeat; ++i)
+    runs.push_back(runOnce(cfg));
+
+  printf("  %-16s %10s %10s %10s\n", "stage (ms)", "median", "p10", "p90");
+
+  for(int stage = 0; stage < STAGE_COUNT; ++stage)
+  {
+    std::vector<double> ms;
+
+    for(auto& run : runs)
+      ms.push_back(run.seconds[stage] * 1000.0);
+
+    printf("  %-16s %10.2f %10.2f %10.2f\n", STAGES[stage], percentile(ms, 50), percentile(ms, 10), percentile(ms, 90));
+  }
+
+  auto& first = runs[0];
+  bool stable = true;
+
+  for(auto& run : runs)
+  {
+    stable = stable && run.bakeChecksum == first.bakeChecksum
+             && run.meshChecksum == first.meshChecksum
+             && run.targaChecksum == first.targaChecksum;
+  }
+
+  auto const current = Reference { triangleCount, cfg.lights, cfg.occlusion, cfg.size,
+                                   first.bakeChecksum, first.meshChecksum, first.targaChecksum };
+
+  Reference* ref = nullptr;
+
+  for(auto& r : refs)
+  {
+    if(r.sameScene(current))
+      ref = &r;
+  }
+
+  auto const matches = ref && ref->bake == current.bake && ref->mesh == current.mesh && ref->targa == current.targa;
+
+  const char* status = "same as the reference";
+
+  if(!stable)
+    status = "CHANGED BETWEEN RUNS";
+  else if(cfg.updateReference)
+    status = "reference updated";
+  else if(!ref)
+    status = "no reference";
+  else if(!matches)
+    status = "DIFFERENT FROM THE REFERENCE";
+
+  printf("  checksums: bake %016llx mesh %016llx tga %016llx (%s)\n\n",
+         (unsigned long long)current.bake,
+         (unsigned long long)current.mesh,
+         (unsigned long long)current.targa,
+         status);
+
+  fflush(stdout);
+
+  if(!stable)
+    return false;
+
+  if(cfg.updateReference)
+  {
+    if(ref)
+      *ref = current;
+    else
+      refs.push_back(current);
+
+    return true;
+  }
+
+  return !ref || matches;
+}
+
+std::vector<int> parseList(const char* list)
+{
+  std::vector<int> r;
+  auto const s = std::string(list);
+  size_t pos = 0;
+
+  while(pos < s.size())
+  {
+    auto comma = s.find(',', pos);
+
+    if(comma == std::string::npos)
+      comma = s.size();
+
+    r.push_back(atoi(s.substr(pos, comma - pos).c_str()));
+    pos = comma + 1;
+  }
+
+  return r;
+}
+}
+
+int main(int argc, char* argv[])
+{
+  Config cfg;
+
+  for(int i = 1; i < argc; ++i)
+  {
+    auto arg = std::string(argv[i]);
+
+    if(arg == "--triangles" && i + 1 < argc)
+      cfg.triangleCounts = parseList(argv[++i]);
+    else if(arg == "--lights" && i + 1 < argc)
+      cfg.lights = atoi(argv[++i]);
+    else if(arg == "--occlusion" && i + 1 < argc)
+      cfg.occlusion = (float)atof(argv[++i]);
+    else if(arg == "--size" && i + 1 < argc)
+      cfg.size = atoi(argv[++i]);
+    else if(arg == "--repeat" && i + 1 < argc)
+      cfg.repeat = atoi(argv[++i]);
+    else if(arg == "--threads" && i + 1 < argc)
+      cfg.threads = atoi(argv[++i]);
+    else if(arg == "--update-reference")
+      cfg.updateReference = true;
+    else
+    {
+      fprintf(stderr, "Usage: %s [--triangles N,N,...] [--lights N] [--occlusion F] [--size N] [--repeat N] [--threads N] [--update-reference]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  if(cfg.repeat <= 0 || cfg.size <= 0)
+    return 1;
+
+  setThreadCount(cfg.threads);
+
+  auto refs = loadReferences(REFERENCE_PATH);
+  bool ok = true;
+
+  for(auto count : cfg.triangleCounts)
+    ok = benchScene(cfg, count, refs) && ok;
+
+  if(cfg.updateReference && !saveReferences(REFERENCE_PATH, refs))
+  {
+    fprintf(stderr, "Can't write '%s'\n", REFERENCE_PATH);
+    return 1;
+  }
+
+  if(!ok)
+    fprintf(stderr, "Checksums changed: the output isn't the same as the reference's\n");
+
+  return ok ? 0 : 1;
+}